@@ -44,9 +44,10 @@ int main(int argc, char const *argv[])
         int size = file.tellg();
         file.seekg(0, std::ios::beg); // remember to reset the file pointer
 
-        // read the entire file into the buffer the size of the file
-        char* buffer = new char[size];
+        // read the entire file into the buffer the size of the file, +1 for strtok's terminator
+        char* buffer = new char[size + 1];
         file.read(&buffer[0], size);
+        buffer[size] = '\0';
 
         const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r"; // Delimeters for tokenizing
 
@@ -0,0 +1,309 @@
+// batched counting: instead of one tally[word] lookup per token (a likely cache miss each time
+// once the table is bigger than the LLC), the tokenizer collects a batch of words, hashes all of
+// them, prefetches their buckets and only then probes + increments, so the misses overlap
+// runs the current one-at-a-time unordered_map loop on the same input for comparison
+// --synthetic generates a high cardinality corpus in memory instead of reading a file
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <chrono> // for the timer
+
+#define max_batch 64
+
+// flat open addressing table, keys live in one string pool, a slot with count 0 is empty
+struct slot
+{
+    uint64_t hash;
+    uint32_t key_offset;
+    uint32_t key_length;
+    long count;
+};
+
+struct batch_table
+{
+    std::vector<slot> slots;
+    std::vector<char> pool;
+    size_t used = 0;
+
+    batch_table() : slots(1 << 16) {}
+
+    // 8 bytes at a time, no per-byte dependency chain so hashes of a batch overlap in the pipeline
+    static uint64_t hash(const char *word, size_t length)
+    {
+        uint64_t h = length * 0x9e3779b97f4a7c15ULL;
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8){
+            uint64_t chunk;
+            memcpy(&chunk, &word[i], 8);
+            h = (h ^ chunk) * 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, &word[i], length - i);
+        h = (h ^ tail) * 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 29;
+        return h;
+    }
+
+    void prefetch(uint64_t h) const
+    {
+        __builtin_prefetch(&slots[h & (slots.size() - 1)], 1);
+    }
+
+    // returns false if the word is new and the pool can't take it anymore
+    bool add(const char *word, size_t length, uint64_t h, long count)
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i].count != 0){
+            if (slots[i].hash == h && slots[i].key_length == length
+                && memcmp(&pool[slots[i].key_offset], word, length) == 0){
+                slots[i].count += count;
+                return true;
+            }
+            i = (i + 1) & mask;
+        }
+        // new word: its offset and length have to fit in the slot's 32 bits
+        if (pool.size() + length >= UINT32_MAX){
+            return false;
+        }
+        slots[i].hash = h;
+        slots[i].key_offset = pool.size();
+        slots[i].key_length = length;
+        slots[i].count = count;
+        pool.insert(pool.end(), word, word + length);
+        used++;
+        return true;
+    }
+
+    // grow before a batch rather than in the middle of one, so prefetched slots stay valid
+    void reserve(size_t extra)
+    {
+        if (2 * (used + extra) <= slots.size()){
+            return;
+        }
+        std::vector<slot> old_slots(slots.size() * 2);
+        old_slots.swap(slots);
+        size_t mask = slots.size() - 1;
+        for (const slot &s : old_slots){
+            if (s.count == 0){
+                continue;
+            }
+            size_t i = s.hash & mask;
+            while (slots[i].count != 0){
+                i = (i + 1) & mask;
+            }
+            slots[i] = s;
+        }
+    }
+};
+
+bool compare(const std::pair<std::string, long> &a, const std::pair<std::string, long> &b)
+{
+    return a.second > b.second;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2 || (strcmp(argv[1], "--synthetic") == 0 && argc < 4))
+    {
+        std::cout << "Usage: " << argv[0] << " <filename>" << " [batch_size]" << std::endl;
+        std::cout << "       " << argv[0] << " --synthetic <num_words> <vocab_size>" << " [batch_size]" << std::endl;
+        return 1;
+    }
+
+    const bool synthetic = strcmp(argv[1], "--synthetic") == 0;
+    const int batch_arg = synthetic ? 4 : 2;
+    int batch_size = argc > batch_arg ? atoi(argv[batch_arg]) : 32;
+    batch_size = std::max(1, std::min(batch_size, max_batch));
+    printf("Batch size: %d\n", batch_size);
+
+    char *buffer;
+    long size;
+    if (synthetic)
+    {
+        // num_words words drawn uniformly from vocab_size random lowercase words of 6 to 12 chars
+        long num_words = atol(argv[2]);
+        long vocab_size = atol(argv[3]);
+        if (num_words <= 0 || vocab_size <= 0)
+        {
+            std::cout << "Need num_words >= 1 and vocab_size >= 1" << std::endl;
+            return 1;
+        }
+        std::mt19937_64 rng(746);
+        std::vector<std::string> vocab(vocab_size);
+        for (std::string &w : vocab){
+            w.resize(6 + rng() % 7);
+            for (char &c : w){
+                c = 'a' + rng() % 26;
+            }
+        }
+        std::string text;
+        text.reserve(num_words * 10);
+        for (long i = 0; i < num_words; i++){
+            text += vocab[rng() % vocab_size];
+            text += ' ';
+        }
+        size = text.size();
+        buffer = new char[size];
+        memcpy(buffer, text.data(), size);
+        printf("Generated %ld words from a vocabulary of %ld\n", num_words, vocab_size);
+    }
+    else
+    {
+        // read the file in
+        std::ifstream file(argv[1]);
+        if (!file.is_open())
+        {
+            std::cout << "Could not open file " << argv[1] << std::endl;
+            return 1;
+        }
+        std::cout << "Opened file " << argv[1] << std::endl;
+
+        // get the file's size
+        file.seekg(0, std::ios::end);
+        size = file.tellg();
+        file.seekg(0, std::ios::beg); // remember to reset the file pointer
+
+        buffer = new char[size];
+        file.read(&buffer[0], size);
+        file.close();
+    }
+
+    // Delimeters for tokenizing, as a lookup table since we scan the buffer in place
+    const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+    bool is_delim[256] = {false};
+    for (const char *d = delim; *d != '\0'; d++){
+        is_delim[(unsigned char)*d] = true;
+    }
+
+    // one at a time, like the other variants
+    std::unordered_map<std::string, long> tally;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+    {
+        std::string word;
+        long pos = 0;
+        while (pos < size){
+            if (is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+                continue;
+            }
+            long start = pos;
+            while (pos < size && !is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+            }
+            // skip if char count is less than 6
+            if (pos - start < 6){
+                continue;
+            }
+            word.assign(&buffer[start], pos - start);
+            std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+            tally[word] += 1;
+        }
+    }
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+    auto single_us = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+    // batched: tokenize a batch into a scratch arena, hash it, prefetch, then probe
+    batch_table table;
+    start_time = std::chrono::high_resolution_clock::now();
+    {
+        std::vector<char> arena;
+        long offsets[max_batch];
+        long lengths[max_batch];
+        uint64_t hashes[max_batch];
+        long pos = 0;
+        while (pos < size){
+            // fill the batch
+            arena.clear();
+            int count = 0;
+            while (count < batch_size && pos < size){
+                if (is_delim[(unsigned char)buffer[pos]]){
+                    pos++;
+                    continue;
+                }
+                long start = pos;
+                while (pos < size && !is_delim[(unsigned char)buffer[pos]]){
+                    pos++;
+                }
+                // skip if char count is less than 6
+                if (pos - start < 6){
+                    continue;
+                }
+                // turn it to lowercase
+                offsets[count] = arena.size();
+                lengths[count] = pos - start;
+                for (long i = start; i < pos; i++){
+                    arena.push_back(::tolower((unsigned char)buffer[i]));
+                }
+                count++;
+            }
+
+            table.reserve(count);
+            for (int b = 0; b < count; b++){
+                hashes[b] = batch_table::hash(&arena[offsets[b]], lengths[b]);
+            }
+            for (int b = 0; b < count; b++){
+                table.prefetch(hashes[b]);
+            }
+            for (int b = 0; b < count; b++){
+                if (!table.add(&arena[offsets[b]], lengths[b], hashes[b], 1)){
+                    std::cout << "Too many distinct words: the string pool is limited to 4GB (32-bit offsets)" << std::endl;
+                    delete[] buffer;
+                    return 1;
+                }
+            }
+        }
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    auto batch_us = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+    // both tallies have to agree
+    bool match = table.used == tally.size();
+    std::vector<std::pair<std::string, long>> sorted_tally;
+    sorted_tally.reserve(table.used);
+    for (const slot &s : table.slots){
+        if (s.count == 0){
+            continue;
+        }
+        sorted_tally.emplace_back(std::string(&table.pool[s.key_offset], s.key_length), s.count);
+        auto it = tally.find(sorted_tally.back().first);
+        match = match && it != tally.end() && it->second == s.count;
+    }
+
+    // sort the tally by count in desc. order
+    std::sort(sorted_tally.begin(), sorted_tally.end(), compare);
+
+    // output results
+    printf("Chunk size: %ld\n", size);
+    printf("Distinct words: %zu\n", table.used);
+    int i = 0;
+    for (const auto &pair : sorted_tally)
+    {
+        printf("%2d. %s: %ld\n", i, pair.first.c_str(), pair.second);
+
+        if (++i == 10)
+        {
+            break;
+        }
+    }
+
+    printf("Tallies match: %s\n", match ? "yes" : "NO");
+    printf("Time taken to count words (one at a time): %ld microsecs\n", single_us);
+    printf("Time taken to count words (batched): %ld microsecs\n", batch_us);
+    printf("Speedup: %.2fx\n", (double)single_us / std::max(batch_us, 1L));
+
+    // clean up
+    delete[] buffer;
+
+    return match ? 0 : 1;
+}
@@ -59,13 +59,24 @@ int main(int argc, char const *argv[])
         // start the timer
         std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
 
-        char cache[cache_size]; // local cache
+        char cache[cache_size + 1]; // local cache, +1 for strtok's terminator
         int copy_size;
         int buffer_offset = 0; // offset into the buffer holding the file content
         while (size > 0){
             // copy from buffer to cache
             copy_size = size > cache_size ? cache_size : size;
+            // don't cut a word in half: end the copy at the last delimiter, the rest goes in the next one
+            if (copy_size < size){
+                int word_end = copy_size;
+                while (word_end > 0 && strchr(delim, buffer[buffer_offset + word_end]) == NULL){
+                    word_end--;
+                }
+                if (word_end > 0){
+                    copy_size = word_end;
+                }
+            }
             memcpy(&cache[0], &buffer[buffer_offset], copy_size);
+            cache[copy_size] = '\0';
 
             // process file content by tokenizing it
             char *token = std::strtok(&cache[0], delim);
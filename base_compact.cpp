@@ -0,0 +1,328 @@
+// compact tally: an unordered_map<std::string, int> costs a heap node + std::string (+ another heap
+// block for words over 15 chars) + a bucket pointer per distinct word, while most words only show
+// up a handful of times. here the keys are packed into one contiguous string pool referenced by
+// 32-bit offsets, and each slot only holds an 8-bit count that gets promoted to a 64-bit one in a
+// side table when it overflows. counts are 64-bit end to end so huge corpora don't wrap.
+// with --compare the current layout is built on the same input too, to check the counts and
+// compare memory per distinct word (that doubles time and memory, so it's off for big corpora)
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <vector>
+
+#include <chrono> // for the timer
+
+#define small_max 255 // an 8-bit count at this value means "look it up in the wide counts"
+
+// counts the heap bytes the current layout asks for
+size_t heap_bytes = 0;
+size_t heap_blocks = 0;
+
+template <typename T>
+struct counting_allocator
+{
+    typedef T value_type;
+    counting_allocator() {}
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        heap_bytes += n * sizeof(T);
+        heap_blocks++;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n)
+    {
+        heap_bytes -= n * sizeof(T);
+        heap_blocks--;
+        std::allocator<T>().deallocate(p, n);
+    }
+    template <typename U>
+    bool operator==(const counting_allocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const counting_allocator<U> &) const { return false; }
+};
+
+typedef std::basic_string<char, std::char_traits<char>, counting_allocator<char>> counted_string;
+
+struct counted_string_hash
+{
+    size_t operator()(const counted_string &s) const
+    {
+        return std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+    }
+};
+
+typedef std::unordered_map<counted_string, long, counted_string_hash, std::equal_to<counted_string>,
+                           counting_allocator<std::pair<const counted_string, long>>> current_tally;
+
+// pool entry: 1 length byte (or 0xFF + 4 byte length for very long words) followed by the word
+struct compact_tally
+{
+    std::vector<uint32_t> offsets;   // pool offset + 1 per slot, 0 is an empty slot
+    std::vector<uint8_t> tags;       // top hash byte per slot, skips most pool compares
+    std::vector<uint8_t> small;      // 8-bit count per slot
+    std::unordered_map<uint32_t, uint64_t> wide; // pool offset -> count, once small overflowed
+    std::vector<char> pool;
+    size_t used = 0;
+
+    compact_tally() : offsets(1024, 0), tags(1024), small(1024) {}
+
+    static uint64_t hash(const char *word, size_t length)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++){
+            h ^= (unsigned char)word[i];
+            h *= 1099511628211ULL;
+        }
+        return h ^ (h >> 29);
+    }
+
+    std::string_view key(uint32_t offset) const
+    {
+        const unsigned char *p = (const unsigned char *)&pool[offset];
+        if (p[0] != 0xFF){
+            return std::string_view((const char *)p + 1, p[0]);
+        }
+        uint32_t length;
+        memcpy(&length, p + 1, 4);
+        return std::string_view((const char *)p + 5, length);
+    }
+
+    uint64_t count(size_t slot) const
+    {
+        return small[slot] == small_max ? wide.at(offsets[slot] - 1) : small[slot];
+    }
+
+    // returns false if the word is new and the pool can't take it anymore
+    bool add(const char *word, size_t length)
+    {
+        // grow at 3/4 load
+        if (4 * (used + 1) > 3 * offsets.size()){
+            grow();
+        }
+        uint64_t h = hash(word, length);
+        size_t mask = offsets.size() - 1;
+        size_t slot = h & mask;
+        uint8_t tag = h >> 56;
+        while (offsets[slot] != 0){
+            if (tags[slot] == tag && key(offsets[slot] - 1) == std::string_view(word, length)){
+                // bump the small count, promote it on overflow
+                if (small[slot] < small_max - 1){
+                    small[slot]++;
+                }
+                else if (small[slot] == small_max - 1){
+                    small[slot] = small_max;
+                    wide[offsets[slot] - 1] = small_max;
+                }
+                else{
+                    wide[offsets[slot] - 1]++;
+                }
+                return true;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        // new word: append it to the pool, as long as its offset + 1 still fits in 32 bits
+        if (pool.size() + 5 + length >= UINT32_MAX){
+            return false;
+        }
+        offsets[slot] = pool.size() + 1;
+        tags[slot] = tag;
+        small[slot] = 1;
+        if (length < 0xFF){
+            pool.push_back((char)length);
+        }
+        else{
+            uint32_t long_length = length;
+            pool.push_back((char)0xFF);
+            pool.insert(pool.end(), (const char *)&long_length, (const char *)&long_length + 4);
+        }
+        pool.insert(pool.end(), word, word + length);
+        used++;
+        return true;
+    }
+
+    void grow()
+    {
+        std::vector<uint32_t> old_offsets(offsets.size() * 2, 0);
+        std::vector<uint8_t> old_tags(tags.size() * 2);
+        std::vector<uint8_t> old_small(small.size() * 2);
+        old_offsets.swap(offsets);
+        old_tags.swap(tags);
+        old_small.swap(small);
+        size_t mask = offsets.size() - 1;
+        for (size_t i = 0; i < old_offsets.size(); i++){
+            if (old_offsets[i] == 0){
+                continue;
+            }
+            std::string_view k = key(old_offsets[i] - 1);
+            size_t slot = hash(k.data(), k.size()) & mask;
+            while (offsets[slot] != 0){
+                slot = (slot + 1) & mask;
+            }
+            offsets[slot] = old_offsets[i];
+            tags[slot] = old_tags[i];
+            small[slot] = old_small[i];
+        }
+    }
+
+    // slots + pool + the wide side table (node + bucket pointer per promoted word)
+    size_t bytes() const
+    {
+        size_t wide_bytes = wide.size() * (sizeof(void *) + sizeof(std::pair<const uint32_t, uint64_t>) + sizeof(size_t))
+                          + wide.bucket_count() * sizeof(void *);
+        return offsets.capacity() * sizeof(uint32_t) + tags.capacity() + small.capacity() + pool.capacity() + wide_bytes;
+    }
+};
+
+bool compare(const std::pair<std::string_view, uint64_t> &a, const std::pair<std::string_view, uint64_t> &b)
+{
+    return a.second > b.second;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "--compare") != 0))
+    {
+        std::cout << "Usage: " << argv[0] << " <filename>" << " [--compare]" << std::endl;
+        return 1;
+    }
+    const bool compare_layouts = argc == 3;
+
+    // read the file in
+    std::ifstream file(argv[1]);
+
+    if (!file.is_open())
+    {
+        std::cout << "Could not open file " << argv[1] << std::endl;
+        return 1;
+    }
+    else
+    {
+        std::cout << "Opened file " << argv[1] << std::endl;
+
+        // get the file's size
+        file.seekg(0, std::ios::end);
+        long size = file.tellg();
+        file.seekg(0, std::ios::beg); // remember to reset the file pointer
+
+        // read the entire file into the buffer the size of the file
+        char *buffer = new char[size];
+        file.read(&buffer[0], size);
+
+        // Delimeters for tokenizing, as a lookup table since we scan the buffer in place
+        const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+        bool is_delim[256] = {false};
+        for (const char *d = delim; *d != '\0'; d++){
+            is_delim[(unsigned char)*d] = true;
+        }
+
+        compact_tally tally;
+
+        // start the timer
+        std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+        std::string word;
+        long pos = 0;
+        while (pos < size){
+            if (is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+                continue;
+            }
+            long start = pos;
+            while (pos < size && !is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+            }
+            // skip if char count is less than 6
+            if (pos - start < 6){
+                continue;
+            }
+            // turn it to lowercase, count to tally
+            word.assign(&buffer[start], pos - start);
+            std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+            if (!tally.add(word.data(), word.size())){
+                std::cout << "Too many distinct words: the string pool is limited to 4GB (32-bit offsets)" << std::endl;
+                delete[] buffer;
+                return 1;
+            }
+        }
+        // stop the timer
+        std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+
+        // the current layout on the same words, only to check the counts and measure its memory
+        current_tally reference;
+        pos = 0;
+        while (compare_layouts && pos < size){
+            if (is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+                continue;
+            }
+            long start = pos;
+            while (pos < size && !is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+            }
+            if (pos - start < 6){
+                continue;
+            }
+            counted_string ref_word(&buffer[start], pos - start);
+            std::transform(ref_word.begin(), ref_word.end(), ref_word.begin(), ::tolower);
+            reference[ref_word] += 1;
+        }
+
+        file.close();
+
+        // sort the tally by count in desc. order
+        std::vector<std::pair<std::string_view, uint64_t>> sorted_tally;
+        sorted_tally.reserve(tally.used);
+        bool match = !compare_layouts || tally.used == reference.size();
+        for (size_t slot = 0; slot < tally.offsets.size(); slot++){
+            if (tally.offsets[slot] == 0){
+                continue;
+            }
+            sorted_tally.emplace_back(tally.key(tally.offsets[slot] - 1), tally.count(slot));
+            if (compare_layouts){
+                auto it = reference.find(counted_string(sorted_tally.back().first));
+                match = match && it != reference.end() && (uint64_t)it->second == sorted_tally.back().second;
+            }
+        }
+        std::sort(sorted_tally.begin(), sorted_tally.end(), compare);
+
+        // output results, we only need the top 10
+        printf("Chunk size: %ld\n", size);
+        int i = 0;
+        for (const auto &pair : sorted_tally){
+            printf("%2d. %.*s: %lu\n", i, (int)pair.first.size(), pair.first.data(), pair.second);
+
+            if (++i == 10){
+                break;
+            }
+        }
+
+        // memory per distinct word, the current layout doesn't include malloc's per block overhead
+        size_t distinct = std::max(tally.used, (size_t)1);
+        printf("Distinct words: %zu (%zu promoted to 64-bit counts)\n", tally.used, tally.wide.size());
+        printf("Compact tally: %zu bytes, %.1f bytes per distinct word\n", tally.bytes(), (double)tally.bytes() / distinct);
+        if (compare_layouts){
+            printf("unordered_map<string, long>: %zu bytes in %zu blocks, %.1f bytes per distinct word\n",
+                   heap_bytes, heap_blocks, (double)heap_bytes / distinct);
+            printf("Tallies match: %s\n", match ? "yes" : "NO");
+        }
+
+        // the time taken
+        auto duration = end_time - start_time;
+        auto duration_ms = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+        printf("Time taken to count words: %ld microsecs\n", duration_ms.count());
+
+        // clean up
+        delete[] buffer;
+        return match ? 0 : 1;
+    }
+}
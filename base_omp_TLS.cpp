@@ -48,8 +48,9 @@ int main(int argc, char const *argv[])
 
         // read the entire file into the buffer the size of the file
         // std::vector<char> buffer(size);
-        char *buffer = new char[size];
+        char *buffer = new char[size + 1];
         file.read(&buffer[0], size);
+        buffer[size] = '\0'; // strtok needs the last share terminated
 
         // Delimeter for tokenizing the chunks
         const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
@@ -76,10 +77,31 @@ int main(int argc, char const *argv[])
             // with the offset of: thread_id * (buffer_size / num_threads)
             int chunk_size = buffer_size / num_threads;
             int offset = thread_id * chunk_size;
+            int end = thread_id == num_threads - 1 ? buffer_size : offset + chunk_size;
+
+            // move both ends of the share up to the next delimiter so no word is split between two threads
+            while (offset > 0 && offset < buffer_size && strchr(delim, buffer[offset - 1]) == NULL)
+            {
+                offset++;
+            }
+            while (end > 0 && end < buffer_size && strchr(delim, buffer[end - 1]) == NULL)
+            {
+                end++;
+            }
+
+            // strtok writes into the buffer, so every thread has to be done looking at its
+            // neighbours' bytes before anyone starts; after that a thread only touches its own share
+            #pragma omp barrier
+
+            // terminate the share at its last delimiter so strtok never runs into the next one
+            if (offset < end && end < buffer_size)
+            {
+                buffer[end - 1] = '\0';
+            }
 
             // process its share of the buffer by tokenizing it
             char *hold;
-            char *token = strtok_r(&buffer[offset], delim, &hold); // thread-safe
+            char *token = offset < end ? strtok_r(&buffer[offset], delim, &hold) : NULL; // thread-safe
 
             // local tally
             std::unordered_map<std::string, int> local_tally;
@@ -99,11 +121,6 @@ int main(int argc, char const *argv[])
                 local_tally[word] += 1;
                 
                 token = strtok_r(NULL, delim, &hold);
-                // break if we read enough so each thread reads the same amount
-                if (token >= &buffer[offset + chunk_size])
-                {
-                    break;
-                }
             }
 
             // merge to shared tally
@@ -26,7 +26,7 @@ int main(int argc, char const *argv[])
     if (argc != 3)
     {
         std::cout << "Usage: " << argv[0] << " <filename>"
-                  << " <num_threads>" << std::endl;
+                  << " <cache_size>" << std::endl;
         return 1;
     }
 
@@ -75,13 +75,25 @@ int main(int argc, char const *argv[])
             // with the offset of: thread_id * (buffer_size / num_threads)
             int chunk_size = buffer_size / num_threads;
             int offset = thread_id * chunk_size;
+            int end = thread_id == num_threads - 1 ? buffer_size : offset + chunk_size;
+
+            // move both ends of the share up to the next delimiter so no word is split between two threads
+            while (offset > 0 && offset < buffer_size && strchr(delim, buffer[offset - 1]) == NULL)
+            {
+                offset++;
+            }
+            while (end > 0 && end < buffer_size && strchr(delim, buffer[end - 1]) == NULL)
+            {
+                end++;
+            }
+            chunk_size = end - offset;
 
             // local tally
             std::unordered_map<std::string, int> local_tally;
 
             // local cache space
             const int cache_size = atoi(argv[2]) * 1024;
-            char local_cache[cache_size];
+            char local_cache[cache_size + 1]; // +1 for strtok's terminator
 
             int copy_size = 0;
 
@@ -89,7 +101,21 @@ int main(int argc, char const *argv[])
             {
                 // copy from buffer to local cache
                 copy_size = chunk_size > cache_size ? cache_size : chunk_size;
+                // don't cut a word in half: end the copy at the last delimiter, the rest goes in the next one
+                if (copy_size < chunk_size)
+                {
+                    int word_end = copy_size;
+                    while (word_end > 0 && strchr(delim, buffer[offset + word_end]) == NULL)
+                    {
+                        word_end--;
+                    }
+                    if (word_end > 0)
+                    {
+                        copy_size = word_end;
+                    }
+                }
                 memcpy(&local_cache[0], &buffer[offset], copy_size);
+                local_cache[copy_size] = '\0';
 
                 // process its share of the buffer by tokenizing it
                 char *hold;
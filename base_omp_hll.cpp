@@ -0,0 +1,237 @@
+// distinct word estimation with HyperLogLog, done in the same pass as the tokenizer
+// each thread keeps its own registers and they're merged by max at the end
+// --distinct-only skips the exact tally so the whole thing runs in a fixed 16KB per thread,
+// otherwise the exact tally is built too and the estimate is checked against tally.size()
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+#include <chrono> // for the timer
+
+#include <omp.h>
+
+#define hll_precision 14                       // 2^14 registers, ~0.8% standard error
+#define hll_registers (1 << hll_precision)
+#define hash_batch 32                          // hashes computed before touching the registers
+
+// 64-bit FNV-1a over the lowercased word + murmur3's finalizer so the top bits are well mixed
+inline uint64_t hash_word(const char *word, int length)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < length; i++){
+        h ^= (unsigned char)word[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// fold a batch of hashes into the registers in two passes: index (the top bits) and rank (position
+// of the first 1 after them) for the whole batch first, a branch-free loop over plain arrays that
+// the compiler vectorizes at -O2 (the shift always, the clz too where the cpu has a vector lzcnt,
+// e.g. avx512cd), then a scalar scatter-max since two hashes of a batch can hit the same register
+inline void hll_update(uint8_t *registers, const uint64_t *hashes, int count)
+{
+    uint32_t index[hash_batch];
+    uint8_t rank[hash_batch];
+    for (int i = 0; i < count; i++){
+        index[i] = hashes[i] >> (64 - hll_precision);
+        rank[i] = __builtin_clzll((hashes[i] << hll_precision) | (1ULL << (hll_precision - 1))) + 1;
+    }
+    for (int i = 0; i < count; i++){
+        registers[index[i]] = std::max(registers[index[i]], rank[i]);
+    }
+}
+
+double hll_estimate(const uint8_t *registers)
+{
+    const double m = hll_registers;
+    double sum = 0.0;
+    int zeros = 0;
+    for (int i = 0; i < hll_registers; i++){
+        sum += std::ldexp(1.0, -registers[i]);
+        zeros += registers[i] == 0;
+    }
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    // small range correction: linear counting while there are still empty registers
+    if (estimate <= 2.5 * m && zeros > 0){
+        estimate = m * std::log(m / zeros);
+    }
+    return estimate;
+}
+
+bool compare(const std::pair<std::string, int> &a, const std::pair<std::string, int> &b)
+{
+    return a.second > b.second;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "--distinct-only") != 0))
+    {
+        std::cout << "Usage: " << argv[0] << " <filename>" << " [--distinct-only]" << std::endl;
+        return 1;
+    }
+    const bool distinct_only = argc == 3;
+
+    // read the file in
+    std::ifstream file(argv[1]);
+
+    if (!file.is_open())
+    {
+        std::cout << "Could not open file " << argv[1] << std::endl;
+        return 1;
+    }
+    else
+    {
+        std::cout << "Opened file " << argv[1] << std::endl;
+
+        // get the file's size
+        file.seekg(0, std::ios::end);
+        long size = file.tellg();
+        file.seekg(0, std::ios::beg); // remember to reset the file pointer
+
+        // read the entire file into the buffer the size of the file
+        char *buffer = new char[size];
+        file.read(&buffer[0], size);
+
+        // Delimeters for tokenizing, as a lookup table since we scan the buffer in place
+        const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+        bool is_delim[256] = {false};
+        for (const char *d = delim; *d != '\0'; d++){
+            is_delim[(unsigned char)*d] = true;
+        }
+
+        std::unordered_map<std::string, int> tally;
+        uint8_t registers[hll_registers] = {0};
+
+        // start the timer
+        std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+
+        #pragma omp parallel shared(tally, registers)
+        {
+            int num_threads = omp_get_num_threads();
+            int thread_id = omp_get_thread_num();
+
+            long chunk_size = size / num_threads;
+            long offset = thread_id * chunk_size;
+            long end = thread_id == num_threads - 1 ? size : offset + chunk_size;
+
+            // a word straddling the chunk start belongs to the previous thread
+            long pos = offset;
+            if (pos > 0){
+                while (pos < size && !is_delim[(unsigned char)buffer[pos - 1]]){
+                    pos++;
+                }
+            }
+
+            uint8_t local_registers[hll_registers] = {0};
+            std::unordered_map<std::string, int> local_tally;
+            uint64_t hashes[hash_batch];
+            int pending = 0;
+            char word[256];
+
+            // every word starting before the end of the chunk is ours, even if it runs past it
+            while (pos < end){
+                if (is_delim[(unsigned char)buffer[pos]]){
+                    pos++;
+                    continue;
+                }
+                long start = pos;
+                while (pos < size && !is_delim[(unsigned char)buffer[pos]]){
+                    pos++;
+                }
+                long length = pos - start;
+                // skip if char count is less than 6
+                if (length < 6){
+                    continue;
+                }
+
+                // turn it to lowercase
+                std::string long_word;
+                char *lower = word;
+                if (length > (long)sizeof(word)){
+                    long_word.resize(length);
+                    lower = &long_word[0];
+                }
+                for (long i = 0; i < length; i++){
+                    lower[i] = ::tolower((unsigned char)buffer[start + i]);
+                }
+
+                hashes[pending++] = hash_word(lower, length);
+                if (pending == hash_batch){
+                    hll_update(local_registers, hashes, pending);
+                    pending = 0;
+                }
+
+                if (!distinct_only){
+                    local_tally[std::string(lower, length)] += 1;
+                }
+            }
+            hll_update(local_registers, hashes, pending);
+
+            // merge to shared registers + tally
+            #pragma omp critical
+            {
+                for (int i = 0; i < hll_registers; i++){
+                    registers[i] = std::max(registers[i], local_registers[i]);
+                }
+                for (const auto &pair : local_tally){
+                    tally[pair.first] += pair.second;
+                }
+            }
+        }
+
+        double estimate = hll_estimate(registers);
+
+        // stop the timer
+        std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+
+        file.close();
+
+        printf("Chunk size: %ld\n", size);
+        printf("Estimated distinct words: %.0f\n", estimate);
+
+        if (!distinct_only){
+            // cross check against the exact count
+            printf("Exact distinct words: %zu (error %.2f%%)\n", tally.size(),
+                   tally.empty() ? 0.0 : 100.0 * (estimate - tally.size()) / tally.size());
+
+            // sort the tally by count in desc. order
+            std::vector<std::pair<std::string, int>> sorted_tally(tally.begin(), tally.end());
+            std::sort(sorted_tally.begin(), sorted_tally.end(), compare);
+
+            int i = 0;
+            for (const auto &pair : sorted_tally)
+            {
+                printf("%2d. %s: %d\n", i, pair.first.c_str(), pair.second);
+
+                if (++i == 10)
+                {
+                    break;
+                }
+            }
+        }
+
+        auto duration = end_time - start_time;
+        auto duration_ms = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+        printf("Time taken to count words: %ld microsecs\n", duration_ms.count());
+
+        // clean up
+        delete[] buffer;
+    }
+
+    return 0;
+}
@@ -0,0 +1,301 @@
+// n-gram (phrase) counting: same thread-local tally layout as base_omp_TLS.cpp, but each word is
+// interned to a dense integer id during the scan and an n-gram is counted as its ids packed into a
+// key (32 bits per word) in a flat open addressing table: 64-bit keys for up to 2 words, 128-bit
+// ones for 3 or 4, so unigrams and bigrams don't pay for the wider slots and hashing
+// words shorter than min_word_len break the phrase, so only runs of qualifying words are counted
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <vector>
+
+#include <chrono> // for the timer
+
+#include <omp.h>
+
+typedef unsigned __int128 wide_key;
+
+inline size_t hash_key(uint64_t key)
+{
+    uint64_t h = key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline size_t hash_key(wide_key key)
+{
+    return hash_key((uint64_t)((uint64_t)key ^ ((uint64_t)(key >> 64) * 0x9e3779b97f4a7c15ULL)));
+}
+
+// flat open addressing table of packed n-gram keys, a slot with count 0 is empty
+template <typename key_type>
+struct gram_table
+{
+    std::vector<key_type> keys;
+    std::vector<long> counts;
+    size_t used = 0;
+
+    gram_table() : keys(1024), counts(1024, 0) {}
+
+    void add(key_type key, long count)
+    {
+        // keep the load factor under 1/2 so probe chains stay short
+        if (2 * (used + 1) > keys.size()){
+            grow();
+        }
+        size_t mask = keys.size() - 1;
+        size_t slot = hash_key(key) & mask;
+        while (counts[slot] != 0 && keys[slot] != key){
+            slot = (slot + 1) & mask;
+        }
+        if (counts[slot] == 0){
+            keys[slot] = key;
+            used++;
+        }
+        counts[slot] += count;
+    }
+
+    void grow()
+    {
+        std::vector<key_type> old_keys(keys.size() * 2);
+        std::vector<long> old_counts(counts.size() * 2, 0);
+        old_keys.swap(keys);
+        old_counts.swap(counts);
+        used = 0;
+        for (size_t i = 0; i < old_keys.size(); i++){
+            if (old_counts[i] != 0){
+                add(old_keys[i], old_counts[i]);
+            }
+        }
+    }
+};
+
+// word <-> dense id mapping, ids index into words
+struct dictionary
+{
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<const std::string *> words;
+
+    uint32_t intern(const std::string &word)
+    {
+        auto it = ids.emplace(word, (uint32_t)words.size());
+        if (it.second){
+            words.push_back(&it.first->first);
+        }
+        return it.first->second;
+    }
+};
+
+template <typename key_type>
+bool compare(const std::pair<key_type, long> &a, const std::pair<key_type, long> &b)
+{
+    return a.second > b.second;
+}
+
+// counts the n-grams in packed keys of key_type, n * 32 bits have to fit in it
+template <typename key_type>
+void count_grams(const char *buffer, long size, const bool *is_delim, int n, int min_word_len)
+{
+    // the low n * 32 bits of the rolling key hold the current n-gram
+    const key_type key_mask = 32 * n == 8 * (int)sizeof(key_type) ? ~(key_type)0 : (((key_type)1 << (32 * n)) - 1);
+
+    // shared dictionary + tally of n-grams in global ids
+    dictionary dict;
+    gram_table<key_type> tally;
+
+    // start the timer
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+
+    #pragma omp parallel shared(dict, tally)
+    {
+        int num_threads = omp_get_num_threads();
+        int thread_id = omp_get_thread_num();
+
+        long chunk_size = size / num_threads;
+        long offset = thread_id * chunk_size;
+        long end = thread_id == num_threads - 1 ? size : offset + chunk_size;
+
+        // a word straddling the chunk start belongs to the previous thread
+        long own_start = offset;
+        if (own_start > 0){
+            while (own_start < size && !is_delim[(unsigned char)buffer[own_start - 1]]){
+                own_start++;
+            }
+        }
+
+        // back up over the n - 1 words before our first one: they're the context for the
+        // n-grams ending in our chunk, but the previous thread counts any n-gram ending in them
+        long pos = own_start;
+        for (int w = 0; w < n - 1 && pos > 0; w++){
+            while (pos > 0 && is_delim[(unsigned char)buffer[pos - 1]]){
+                pos--;
+            }
+            while (pos > 0 && !is_delim[(unsigned char)buffer[pos - 1]]){
+                pos--;
+            }
+        }
+
+        // local dictionary + tally in local ids
+        dictionary local_dict;
+        gram_table<key_type> local_tally;
+
+        key_type key = 0;
+        int filled = 0; // number of qualifying words currently in the key
+        std::string word;
+
+        // every word starting before the end of the chunk is ours, even if it runs past it
+        while (pos < end){
+            if (is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+                continue;
+            }
+            long start = pos;
+            while (pos < size && !is_delim[(unsigned char)buffer[pos]]){
+                pos++;
+            }
+
+            // short words break the phrase
+            if (pos - start < min_word_len){
+                filled = 0;
+                continue;
+            }
+
+            // turn it to lowercase
+            word.assign(&buffer[start], pos - start);
+            std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+
+            key = ((key << 32) | local_dict.intern(word)) & key_mask;
+            if (filled < n){
+                filled++;
+            }
+            if (filled == n && start >= own_start){
+                local_tally.add(key, 1);
+            }
+        }
+
+        // merge to shared tally: remap local ids to global ones, then repack every key
+        #pragma omp critical
+        {
+            std::vector<uint32_t> remap(local_dict.words.size());
+            for (size_t id = 0; id < remap.size(); id++){
+                remap[id] = dict.intern(*local_dict.words[id]);
+            }
+            for (size_t slot = 0; slot < local_tally.keys.size(); slot++){
+                if (local_tally.counts[slot] == 0){
+                    continue;
+                }
+                key_type local_key = local_tally.keys[slot];
+                key_type global_key = 0;
+                for (int w = n - 1; w >= 0; w--){
+                    global_key = (global_key << 32) | remap[(uint32_t)(local_key >> (32 * w))];
+                }
+                tally.add(global_key, local_tally.counts[slot]);
+            }
+        }
+    }
+
+    // stop the timer
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+
+    // sort the tally by count in desc. order
+    std::vector<std::pair<key_type, long>> sorted_tally;
+    sorted_tally.reserve(tally.used);
+    for (size_t slot = 0; slot < tally.keys.size(); slot++){
+        if (tally.counts[slot] != 0){
+            sorted_tally.emplace_back(tally.keys[slot], tally.counts[slot]);
+        }
+    }
+    std::sort(sorted_tally.begin(), sorted_tally.end(), compare<key_type>);
+
+    // output results
+    printf("Chunk size: %ld\n", size);
+    printf("Distinct words: %zu, distinct %d-grams: %zu\n", dict.words.size(), n, tally.used);
+    int i = 0;
+    for (const auto &pair : sorted_tally)
+    {
+        // unpack the ids back into words, oldest word is in the highest bits
+        std::string phrase;
+        for (int w = n - 1; w >= 0; w--){
+            phrase += *dict.words[(uint32_t)(pair.first >> (32 * w))];
+            if (w > 0){
+                phrase += ' ';
+            }
+        }
+        printf("%2d. %s: %ld\n", i, phrase.c_str(), pair.second);
+
+        if (++i == 10)
+        {
+            break;
+        }
+    }
+
+    auto duration = end_time - start_time;
+    auto duration_ms = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+    printf("Time taken to count words: %ld microsecs\n", duration_ms.count());
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 3 || argc > 4)
+    {
+        std::cout << "Usage: " << argv[0] << " <filename>" << " <n>" << " [min_word_len]" << std::endl;
+        return 1;
+    }
+
+    const int n = atoi(argv[2]);
+    const int min_word_len = argc == 4 ? atoi(argv[3]) : 1;
+    if (n < 1 || n > 4)
+    {
+        std::cout << "n must be between 1 and 4" << std::endl;
+        return 1;
+    }
+
+    // read the file in
+    std::ifstream file(argv[1]);
+
+    if (!file.is_open())
+    {
+        std::cout << "Could not open file " << argv[1] << std::endl;
+        return 1;
+    }
+    else
+    {
+        std::cout << "Opened file " << argv[1] << std::endl;
+
+        // get the file's size
+        file.seekg(0, std::ios::end);
+        long size = file.tellg();
+        file.seekg(0, std::ios::beg); // remember to reset the file pointer
+
+        // read the entire file into the buffer the size of the file
+        char *buffer = new char[size];
+        file.read(&buffer[0], size);
+
+        // Delimeters for tokenizing, as a lookup table since we scan the buffer in place
+        const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+        bool is_delim[256] = {false};
+        for (const char *d = delim; *d != '\0'; d++){
+            is_delim[(unsigned char)*d] = true;
+        }
+
+        if (n <= 2){
+            count_grams<uint64_t>(buffer, size, is_delim, n, min_word_len);
+        }
+        else{
+            count_grams<wide_key>(buffer, size, is_delim, n, min_word_len);
+        }
+        file.close();
+
+        // clean up
+        delete[] buffer;
+    }
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+// same per-thread tally + local cache algorithm as base_omp_TLS_cache.cpp, runnable on two backends:
+//   omp  - a #pragma omp parallel region per run (placement is up to OMP_PROC_BIND / OMP_PLACES)
+//   pool - a persistent pool of std::threads, each pinned to one cpu, woken up for every run
+// the count is repeated so we can see what thread startup costs when we run batches in one process;
+// per-worker state (local tally + cache window) is kept between runs on both backends
+// pinning: ht puts one worker per physical core before doubling up on hyperthread siblings,
+// linear takes the allowed cpus in order, none leaves it to the scheduler
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <map>
+
+#include <chrono> // for the timer
+
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+
+// state a worker keeps between runs, one cache line each so workers updating their own
+// tally's size/bucket fields don't invalidate their neighbours' lines
+struct alignas(64) worker_state
+{
+    std::unordered_map<std::string, int> local_tally;
+    std::vector<char> local_cache;
+};
+
+// the cpus this process may run on, in the order workers get pinned to them
+std::vector<int> placement(const char *pinning)
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+        if (CPU_ISSET(cpu, &allowed)){
+            cpus.push_back(cpu);
+        }
+    }
+    if (strcmp(pinning, "ht") != 0){
+        return cpus;
+    }
+
+    // group the cpus by physical core, then take the first sibling of every core, then the second...
+    std::map<std::pair<int, int>, std::vector<int>> cores; // (package, core) -> cpus
+    for (int cpu : cpus){
+        int ids[2] = {0, cpu};
+        const char *names[2] = {"physical_package_id", "core_id"};
+        for (int i = 0; i < 2; i++){
+            std::ifstream topology("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + names[i]);
+            topology >> ids[i];
+        }
+        cores[std::make_pair(ids[0], ids[1])].push_back(cpu);
+    }
+    std::vector<int> ordered;
+    for (size_t sibling = 0; ordered.size() < cpus.size(); sibling++){
+        for (const auto &core : cores){
+            if (sibling < core.second.size()){
+                ordered.push_back(core.second[sibling]);
+            }
+        }
+    }
+    return ordered;
+}
+
+// persistent workers, run() hands every worker the same job and waits for all of them
+struct thread_pool
+{
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable start_cv, done_cv;
+    std::function<void(int)> job;
+    long generation = 0;
+    int pending = 0;
+    bool stop = false;
+
+    thread_pool(int num_threads, const std::vector<int> &cpus)
+    {
+        for (int id = 0; id < num_threads; id++){
+            threads.emplace_back(&thread_pool::worker, this, id);
+            if (!cpus.empty()){
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[id % cpus.size()], &set);
+                pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set);
+            }
+        }
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+        start_cv.notify_all();
+        for (std::thread &t : threads){
+            t.join();
+        }
+    }
+
+    void run(const std::function<void(int)> &work)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        job = work;
+        pending = threads.size();
+        generation++;
+        start_cv.notify_all();
+        done_cv.wait(guard, [this]{ return pending == 0; });
+    }
+
+    void worker(int id)
+    {
+        long seen = 0;
+        while (true){
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                start_cv.wait(guard, [this, seen]{ return stop || generation != seen; });
+                if (stop){
+                    return;
+                }
+                seen = generation;
+            }
+            job(id);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (--pending == 0){
+                    done_cv.notify_one();
+                }
+            }
+        }
+    }
+};
+
+bool compare(const std::pair<std::string, int> &a, const std::pair<std::string, int> &b)
+{
+    return a.second > b.second;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 5 || argc > 7)
+    {
+        std::cout << "Usage: " << argv[0] << " <filename>" << " <cache_size>" << " <omp|pool>" << " <num_threads>"
+                  << " [repeats]" << " [ht|linear|none]" << std::endl;
+        return 1;
+    }
+
+    const int cache_size = atoi(argv[2]) * 1024;
+    const bool use_pool = strcmp(argv[3], "pool") == 0;
+    const int num_threads = atoi(argv[4]);
+    const int repeats = argc > 5 ? atoi(argv[5]) : 10;
+    const char *pinning = argc > 6 ? argv[6] : "ht";
+    if (cache_size <= 0 || num_threads <= 0 || repeats <= 0 || (!use_pool && strcmp(argv[3], "omp") != 0)
+        || (strcmp(pinning, "ht") != 0 && strcmp(pinning, "linear") != 0 && strcmp(pinning, "none") != 0))
+    {
+        std::cout << "Need cache_size, num_threads, repeats > 0, backend omp or pool, pinning ht, linear or none" << std::endl;
+        return 1;
+    }
+
+    // read the file in
+    std::ifstream file(argv[1]);
+
+    if (!file.is_open())
+    {
+        std::cout << "Could not open file " << argv[1] << std::endl;
+        return 1;
+    }
+    else
+    {
+        std::cout << "Opened file " << argv[1] << std::endl;
+
+        // get the file's size
+        file.seekg(0, std::ios::end);
+        long size = file.tellg();
+        file.seekg(0, std::ios::beg); // remember to reset the file pointer
+
+        // read the entire file into the buffer the size of the file
+        char *buffer = new char[size];
+        file.read(&buffer[0], size);
+        file.close();
+
+        // Delimeter for tokenizing the chunks
+        const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+
+        std::unordered_map<std::string, int> tally;
+        std::mutex tally_lock;
+        std::vector<worker_state> states(num_threads);
+
+        // one worker's share of a run, identical on both backends
+        std::function<void(int)> count_share = [&](int thread_id){
+            worker_state &state = states[thread_id];
+            state.local_tally.clear(); // keeps its buckets from the last run
+            state.local_cache.resize(cache_size + 1); // +1 for strtok's terminator
+
+            long chunk_size = size / num_threads;
+            long offset = thread_id * chunk_size;
+            long end = thread_id == num_threads - 1 ? size : offset + chunk_size;
+
+            // move both ends of the share up to the next delimiter so no word is split between two threads
+            while (offset > 0 && offset < size && strchr(delim, buffer[offset - 1]) == NULL){
+                offset++;
+            }
+            while (end > 0 && end < size && strchr(delim, buffer[end - 1]) == NULL){
+                end++;
+            }
+
+            std::string word;
+            while (offset < end){
+                // copy from buffer to local cache, ending at a delimiter so no word gets cut in half
+                long copy_size = std::min((long)cache_size, end - offset);
+                if (copy_size < end - offset){
+                    long word_end = copy_size;
+                    while (word_end > 0 && strchr(delim, buffer[offset + word_end]) == NULL){
+                        word_end--;
+                    }
+                    if (word_end > 0){
+                        copy_size = word_end;
+                    }
+                }
+                memcpy(&state.local_cache[0], &buffer[offset], copy_size);
+                state.local_cache[copy_size] = '\0';
+
+                char *hold;
+                char *token = strtok_r(&state.local_cache[0], delim, &hold);
+                while (token != NULL){
+                    // turn it to lowercase
+                    word = std::string(token);
+                    std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+                    // skip if char count is less than 6
+                    if (word.length() >= 6){
+                        state.local_tally[word] += 1;
+                    }
+                    token = strtok_r(NULL, delim, &hold);
+                }
+                offset += copy_size;
+            }
+
+            // merge to shared tally
+            std::lock_guard<std::mutex> guard(tally_lock);
+            for (const auto &pair : state.local_tally){
+                tally[pair.first] += pair.second;
+            }
+        };
+
+        std::vector<int> cpus;
+        if (strcmp(pinning, "none") != 0){
+            cpus = placement(pinning);
+        }
+        printf("Backend: %s, %d threads, %d repeats, pinning %s\n", argv[3], num_threads, repeats, use_pool ? pinning : "from OMP_PROC_BIND");
+
+        // the pool is created once, its threads live across all repeats
+        std::chrono::time_point<std::chrono::high_resolution_clock> setup_start = std::chrono::high_resolution_clock::now();
+        thread_pool *pool = use_pool ? new thread_pool(num_threads, cpus) : NULL;
+        std::chrono::time_point<std::chrono::high_resolution_clock> setup_end = std::chrono::high_resolution_clock::now();
+
+        std::vector<long> times;
+        for (int r = 0; r < repeats; r++){
+            tally.clear();
+
+            // start the timer
+            std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+            if (use_pool){
+                pool->run(count_share);
+            }
+            else{
+                #pragma omp parallel num_threads(num_threads)
+                {
+                    count_share(omp_get_thread_num());
+                }
+            }
+            // stop the timer
+            std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+            times.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+        }
+        delete pool;
+
+        // sort the tally by count in desc. order
+        std::vector<std::pair<std::string, int>> sorted_tally(tally.begin(), tally.end());
+        std::sort(sorted_tally.begin(), sorted_tally.end(), compare);
+
+        // output results
+        printf("Chunk size: %ld\n", size);
+        int i = 0;
+        for (const auto &pair : sorted_tally)
+        {
+            printf("%2d. %s: %d\n", i, pair.first.c_str(), pair.second);
+
+            if (++i == 10)
+            {
+                break;
+            }
+        }
+
+        long total = 0;
+        for (long t : times){
+            total += t;
+        }
+        auto setup_us = std::chrono::duration_cast<std::chrono::microseconds>(setup_end - setup_start).count();
+        if (use_pool){
+            printf("Pool setup: %ld microsecs\n", setup_us);
+        }
+        printf("First run: %ld microsecs, best: %ld microsecs\n", times.front(), *std::min_element(times.begin(), times.end()));
+        // average over the repeats
+        printf("Time taken to count words: %ld microsecs\n", total / repeats);
+
+        // clean up
+        delete[] buffer;
+    }
+
+    return 0;
+}
@@ -0,0 +1,551 @@
+// resident word count server: loads corpora once, keeps the tally in memory and answers
+// queries over a local unix socket so we don't pay startup + load + full count per top-10 list
+//
+// protocol (one request per line, replies are a single line or a list terminated by "END"):
+//   TOP <k>              -> "<word> <count>" lines (at most 1000), END
+//   COUNT <word>         -> "<count>"
+//   PREFIX <prefix> <k>  -> top k words starting with prefix, "<word> <count>" lines, END
+//   ADD <nbytes>         -> followed by nbytes (up to 256MB) of raw text, replies "OK <words counted> <version>"
+//   LOAD <path>          -> count a file on the server side, replies "OK <words counted> <version>"
+//   STATS                -> "distinct <n> total <n> version <n>"
+//   QUIT                 -> closes the connection
+//
+// queries never block on ingestion: readers grab the currently published snapshot and the
+// ingest thread publishes a new one with an atomic pointer swap once it has merged a batch of
+// documents (RCU style). versions share the word storage and all unchanged count chunks, so a
+// small ADD only costs the words it touches
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <atomic>
+#include <set>
+#include <iterator>
+#include <cstdint>
+#include <cmath>
+#include <cerrno>
+
+#include <chrono> // for the timer
+
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define max_add_bytes (256UL * 1024 * 1024) // biggest document a single ADD may send
+
+// Delimeters for tokenizing
+const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+
+#define word_chunk_size 65536   // words per shared word storage chunk
+#define count_chunk_size 4096   // counts per copy-on-write count chunk
+#define max_top 1000            // longest TOP list that's kept ready
+#define min_recent 4096         // words allowed in the recent index before it's merged into the main one
+
+// words are only ever appended, so every version shares the same chunks: a slot is filled in by
+// the ingest thread before the version that first contains it is published, and never changes after
+struct word_chunk
+{
+    std::string words[word_chunk_size];
+};
+
+struct count_chunk
+{
+    long counts[count_chunk_size] = {0};
+};
+
+// immutable view of the tally that readers query, everything big is shared with the previous version
+struct snapshot
+{
+    std::shared_ptr<const std::vector<std::shared_ptr<word_chunk>>> words; // id -> word
+    std::shared_ptr<const std::vector<std::shared_ptr<const count_chunk>>> counts; // id -> count, only touched chunks are copied
+    size_t num_words = 0;
+    std::shared_ptr<const std::vector<uint32_t>> index;  // ids sorted by word, for COUNT + PREFIX
+    std::shared_ptr<const std::vector<uint32_t>> recent; // ids added since index was built, sorted by word
+    std::vector<std::pair<uint32_t, long>> top;          // the first max_top ids by desc. count, for TOP
+    long total = 0;                                      // number of words counted
+    unsigned long version = 0;
+
+    snapshot()
+        : words(std::make_shared<std::vector<std::shared_ptr<word_chunk>>>()),
+          counts(std::make_shared<std::vector<std::shared_ptr<const count_chunk>>>()),
+          index(std::make_shared<std::vector<uint32_t>>()),
+          recent(std::make_shared<std::vector<uint32_t>>()) {}
+
+    const std::string &word(uint32_t id) const
+    {
+        return (*words)[id / word_chunk_size]->words[id % word_chunk_size];
+    }
+
+    long count(uint32_t id) const
+    {
+        return (*counts)[id / count_chunk_size]->counts[id % count_chunk_size];
+    }
+
+    // the id of word in a word sorted list, or -1
+    long find(const std::vector<uint32_t> &ids, const std::string &w) const
+    {
+        auto it = std::lower_bound(ids.begin(), ids.end(), w,
+            [this](uint32_t id, const std::string &p){ return word(id) < p; });
+        return it != ids.end() && word(*it) == w ? (long)*it : -1;
+    }
+
+    // ids in [first, last) of a word sorted list whose word starts with prefix
+    std::pair<std::vector<uint32_t>::const_iterator, std::vector<uint32_t>::const_iterator>
+    prefix_range(const std::vector<uint32_t> &ids, const std::string &prefix) const
+    {
+        auto first = std::lower_bound(ids.begin(), ids.end(), prefix,
+            [this](uint32_t id, const std::string &p){ return word(id) < p; });
+        auto last = first;
+        while (last != ids.end() && word(*last).compare(0, prefix.size(), prefix) == 0){
+            last++;
+        }
+        return std::make_pair(first, last);
+    }
+};
+
+// one pending "add this document" request for the ingest thread
+struct ingest_job
+{
+    std::unordered_map<std::string, long> tally; // already tokenized by the connection thread
+    std::promise<std::pair<long, unsigned long>> done; // words counted, version that includes them
+};
+
+std::shared_ptr<const snapshot> current = std::make_shared<const snapshot>();
+
+std::mutex queue_lock;
+std::condition_variable queue_cv;
+std::deque<ingest_job *> queue;
+
+// tokenize + count a chunk of text the same way base.cpp does, returns the number of words counted
+long count_words(std::string &text, std::unordered_map<std::string, long> &tally)
+{
+    long counted = 0;
+    char *hold;
+    char *token = strtok_r(&text[0], delim, &hold);
+    std::string word;
+    while (token != NULL){
+        word = std::string(token);
+        // skip if char count is less than 6
+        if (word.length() < 6){
+            token = strtok_r(NULL, delim, &hold);
+            continue;
+        }
+        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+        tally[word] += 1;
+        counted++;
+        token = strtok_r(NULL, delim, &hold);
+    }
+    return counted;
+}
+
+// single writer: drains every pending job and publishes one new snapshot for all of them
+// a version costs O(changed words) plus the copied count chunks, the words themselves are never copied
+void ingest_loop()
+{
+    // writer only state, readers never see these
+    std::unordered_map<std::string, uint32_t> ids;
+    std::set<std::pair<long, uint32_t>, std::greater<std::pair<long, uint32_t>>> ranking; // ties go to the higher id
+
+    while (true){
+        std::deque<ingest_job *> batch;
+        {
+            std::unique_lock<std::mutex> lock(queue_lock);
+            queue_cv.wait(lock, []{ return !queue.empty(); });
+            batch.swap(queue);
+        }
+
+        std::shared_ptr<const snapshot> old = std::atomic_load(&current);
+        std::shared_ptr<snapshot> next = std::make_shared<snapshot>(*old);
+        std::shared_ptr<std::vector<std::shared_ptr<word_chunk>>> words;
+        std::shared_ptr<std::vector<std::shared_ptr<const count_chunk>>> counts
+            = std::make_shared<std::vector<std::shared_ptr<const count_chunk>>>(*old->counts);
+        std::vector<bool> copied(counts->size(), false); // count chunks already private to this version
+        std::vector<uint32_t> added;
+
+        std::vector<long> counted(batch.size(), 0);
+        for (size_t b = 0; b < batch.size(); b++){
+            for (const auto &pair : batch[b]->tally){
+                counted[b] += pair.second;
+
+                auto it = ids.find(pair.first);
+                uint32_t id;
+                if (it == ids.end()){
+                    // new word: goes in the next free slot, a new chunk is only needed every word_chunk_size words
+                    id = next->num_words++;
+                    if (id / word_chunk_size >= next->words->size()){
+                        if (!words){
+                            words = std::make_shared<std::vector<std::shared_ptr<word_chunk>>>(*next->words);
+                            next->words = words;
+                        }
+                        words->push_back(std::make_shared<word_chunk>());
+                    }
+                    (*next->words)[id / word_chunk_size]->words[id % word_chunk_size] = pair.first;
+                    if (id / count_chunk_size >= counts->size()){
+                        counts->push_back(std::make_shared<count_chunk>());
+                        copied.push_back(true);
+                    }
+                    ids.emplace(pair.first, id);
+                    added.push_back(id);
+                }
+                else{
+                    id = it->second;
+                }
+
+                size_t chunk = id / count_chunk_size;
+                if (!copied[chunk]){
+                    (*counts)[chunk] = std::make_shared<count_chunk>(*(*counts)[chunk]);
+                    copied[chunk] = true;
+                }
+                // the chunk was just copied for this version and nobody else can see it yet
+                long &count = const_cast<count_chunk &>(*(*counts)[chunk]).counts[id % count_chunk_size];
+                if (count > 0){
+                    ranking.erase(std::make_pair(count, id));
+                }
+                count += pair.second;
+                ranking.insert(std::make_pair(count, id));
+            }
+            next->total += counted[b];
+        }
+        next->counts = counts;
+
+        // new words go in the small recent index (O(recent) per version that adds words), which is
+        // folded into the main one (an O(N) merge) once it's bigger than ~16 sqrt(N) words
+        if (!added.empty()){
+            const snapshot &snap = *next;
+            auto by_word = [&snap](uint32_t a, uint32_t b){ return snap.word(a) < snap.word(b); };
+            std::sort(added.begin(), added.end(), by_word);
+            std::shared_ptr<std::vector<uint32_t>> recent = std::make_shared<std::vector<uint32_t>>();
+            recent->reserve(old->recent->size() + added.size());
+            std::merge(old->recent->begin(), old->recent->end(), added.begin(), added.end(), std::back_inserter(*recent), by_word);
+            if (recent->size() > std::max((size_t)min_recent, (size_t)(16 * std::sqrt((double)next->num_words)))){
+                std::shared_ptr<std::vector<uint32_t>> index = std::make_shared<std::vector<uint32_t>>();
+                index->reserve(old->index->size() + recent->size());
+                std::merge(old->index->begin(), old->index->end(), recent->begin(), recent->end(), std::back_inserter(*index), by_word);
+                next->index = index;
+                recent->clear();
+            }
+            next->recent = recent;
+        }
+
+        // the ranking is kept up to date word by word, publishing only copies its head
+        next->top.clear();
+        for (auto it = ranking.begin(); it != ranking.end() && next->top.size() < max_top; it++){
+            next->top.emplace_back(it->second, it->first);
+        }
+        next->version = old->version + 1;
+
+        // publish, readers still holding the old snapshot keep it alive until they're done
+        std::atomic_store(&current, std::shared_ptr<const snapshot>(next));
+
+        for (size_t b = 0; b < batch.size(); b++){
+            batch[b]->done.set_value(std::make_pair(counted[b], next->version));
+        }
+    }
+}
+
+// hand a tokenized document to the ingest thread and wait until it's visible to queries
+std::pair<long, unsigned long> ingest(std::unordered_map<std::string, long> &tally)
+{
+    ingest_job job;
+    job.tally.swap(tally);
+    std::future<std::pair<long, unsigned long>> done = job.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queue_lock);
+        queue.push_back(&job);
+    }
+    queue_cv.notify_one();
+    return done.get();
+}
+
+bool load_file(const char *filename, std::pair<long, unsigned long> &result)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()){
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    std::unordered_map<std::string, long> tally;
+    count_words(text, tally);
+    result = ingest(tally);
+    return true;
+}
+
+// buffered line / byte reader over a socket
+struct connection
+{
+    int fd;
+    char buffer[64 * 1024];
+    size_t start = 0, end = 0;
+
+    bool fill()
+    {
+        if (start == end){
+            start = end = 0;
+        }
+        ssize_t n = read(fd, &buffer[end], sizeof(buffer) - end);
+        if (n <= 0){
+            return false;
+        }
+        end += n;
+        return true;
+    }
+
+    bool read_line(std::string &line)
+    {
+        line.clear();
+        while (true){
+            char *newline = (char *)memchr(&buffer[start], '\n', end - start);
+            if (newline != NULL){
+                line.append(&buffer[start], newline - &buffer[start]);
+                start = newline - buffer + 1;
+                if (!line.empty() && line.back() == '\r'){
+                    line.pop_back();
+                }
+                return true;
+            }
+            line.append(&buffer[start], end - start);
+            start = end;
+            if (!fill()){
+                return false;
+            }
+        }
+    }
+
+    bool read_bytes(std::string &out, size_t count)
+    {
+        out.clear();
+        out.reserve(count);
+        while (out.size() < count){
+            if (start == end && !fill()){
+                return false;
+            }
+            size_t take = std::min(count - out.size(), end - start);
+            out.append(&buffer[start], take);
+            start += take;
+        }
+        return true;
+    }
+
+    bool write_all(const std::string &reply)
+    {
+        size_t sent = 0;
+        while (sent < reply.size()){
+            ssize_t n = write(fd, reply.data() + sent, reply.size() - sent);
+            if (n <= 0){
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+};
+
+void append_pair(std::string &reply, const std::string &word, long count)
+{
+    reply += word;
+    reply += ' ';
+    reply += std::to_string(count);
+    reply += '\n';
+}
+
+void serve_requests(connection &conn)
+{
+    std::string line, reply;
+
+    while (conn.read_line(line)){
+        // split into command + arguments
+        std::vector<std::string> args;
+        size_t pos = 0;
+        while (pos < line.size()){
+            size_t next = line.find(' ', pos);
+            if (next == std::string::npos){
+                next = line.size();
+            }
+            if (next > pos){
+                args.push_back(line.substr(pos, next - pos));
+            }
+            pos = next + 1;
+        }
+        if (args.empty()){
+            continue;
+        }
+
+        reply.clear();
+        const std::string &cmd = args[0];
+        if (cmd == "TOP" && args.size() == 2){
+            std::shared_ptr<const snapshot> snap = std::atomic_load(&current);
+            size_t k = std::min((size_t)atol(args[1].c_str()), snap->top.size());
+            for (size_t i = 0; i < k; i++){
+                append_pair(reply, snap->word(snap->top[i].first), snap->top[i].second);
+            }
+            reply += "END\n";
+        }
+        else if (cmd == "COUNT" && args.size() == 2){
+            std::shared_ptr<const snapshot> snap = std::atomic_load(&current);
+            std::string word = args[1];
+            std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+            // a word is in exactly one of the two indexes
+            long count = 0;
+            for (const std::vector<uint32_t> *ids : {snap->index.get(), snap->recent.get()}){
+                long id = snap->find(*ids, word);
+                if (id >= 0){
+                    count = snap->count(id);
+                    break;
+                }
+            }
+            reply = std::to_string(count) + "\n";
+        }
+        else if (cmd == "PREFIX" && args.size() == 3){
+            std::shared_ptr<const snapshot> snap = std::atomic_load(&current);
+            std::string prefix = args[1];
+            std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+            size_t k = atol(args[2].c_str());
+
+            // words with the prefix are one contiguous range of each sorted index
+            std::vector<std::pair<uint32_t, long>> matches;
+            for (const std::vector<uint32_t> *ids : {snap->index.get(), snap->recent.get()}){
+                auto range = snap->prefix_range(*ids, prefix);
+                for (auto it = range.first; it != range.second; it++){
+                    matches.emplace_back(*it, snap->count(*it));
+                }
+            }
+            k = std::min(k, matches.size());
+            std::partial_sort(matches.begin(), matches.begin() + k, matches.end(),
+                [&snap](const std::pair<uint32_t, long> &a, const std::pair<uint32_t, long> &b){
+                    return a.second != b.second ? a.second > b.second : snap->word(a.first) < snap->word(b.first);
+                });
+            for (size_t i = 0; i < k; i++){
+                append_pair(reply, snap->word(matches[i].first), matches[i].second);
+            }
+            reply += "END\n";
+        }
+        else if (cmd == "ADD" && args.size() == 2){
+            // the payload length has to be a plain number under the limit, otherwise we can't
+            // tell where the payload ends, so the connection is dropped after the error
+            char *end;
+            errno = 0;
+            unsigned long length = strtoul(args[1].c_str(), &end, 10);
+            if (!isdigit((unsigned char)args[1][0]) || *end != '\0' || errno != 0 || length > max_add_bytes){
+                conn.write_all("ERR bad length, expected 0 to " + std::to_string(max_add_bytes) + " bytes\n");
+                break;
+            }
+            std::string text;
+            if (!conn.read_bytes(text, length)){
+                break;
+            }
+            std::unordered_map<std::string, long> tally;
+            count_words(text, tally);
+            std::pair<long, unsigned long> result = ingest(tally);
+            reply = "OK " + std::to_string(result.first) + " " + std::to_string(result.second) + "\n";
+        }
+        else if (cmd == "LOAD" && args.size() == 2){
+            std::pair<long, unsigned long> result;
+            if (load_file(args[1].c_str(), result)){
+                reply = "OK " + std::to_string(result.first) + " " + std::to_string(result.second) + "\n";
+            }
+            else{
+                reply = "ERR could not open file " + args[1] + "\n";
+            }
+        }
+        else if (cmd == "STATS"){
+            std::shared_ptr<const snapshot> snap = std::atomic_load(&current);
+            reply = "distinct " + std::to_string(snap->num_words) + " total " + std::to_string(snap->total)
+                  + " version " + std::to_string(snap->version) + "\n";
+        }
+        else if (cmd == "QUIT"){
+            break;
+        }
+        else{
+            reply = "ERR unknown command\n";
+        }
+
+        if (!conn.write_all(reply)){
+            break;
+        }
+    }
+}
+
+void serve(int fd)
+{
+    connection conn;
+    conn.fd = fd;
+    // a request that can't be served (e.g. out of memory) only costs this connection, not the server
+    try{
+        serve_requests(conn);
+    }
+    catch (const std::exception &e){
+        conn.write_all(std::string("ERR ") + e.what() + "\n");
+    }
+    close(fd);
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <socket_path>" << " [filename ...]" << std::endl;
+        return 1;
+    }
+
+    // a client hanging up mid-reply shouldn't take the server down
+    signal(SIGPIPE, SIG_IGN);
+
+    std::thread(ingest_loop).detach();
+
+    // load the initial corpora
+    for (int f = 2; f < argc; f++){
+        std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+        std::pair<long, unsigned long> result;
+        if (!load_file(argv[f], result)){
+            std::cout << "Could not open file " << argv[f] << std::endl;
+            return 1;
+        }
+        std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+        auto duration_ms = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        printf("Loaded %s: %ld words in %ld microsecs\n", argv[f], result.first, duration_ms.count());
+    }
+
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(argv[1]) >= sizeof(addr.sun_path))
+    {
+        std::cout << "Socket path too long " << argv[1] << std::endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, argv[1]);
+    unlink(argv[1]);
+    if (server_fd < 0 || bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server_fd, 128) != 0)
+    {
+        std::cout << "Could not listen on " << argv[1] << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    printf("Listening on %s\n", argv[1]);
+    fflush(stdout);
+
+    // one thread per client
+    while (true){
+        int client_fd = accept(server_fd, NULL, NULL);
+        if (client_fd < 0){
+            continue;
+        }
+        std::thread(serve, client_fd).detach();
+    }
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+// sliding window word counts for log streams: "top words in the last N lines / N seconds"
+// same chunk loop as base_cache.cpp, but chunks are read straight from the stream (so "-" reads
+// stdin) and every bucket_lines lines the words seen are closed into a bucket. a bucket's tally is
+// added to the window tally when it enters and subtracted again when it falls out of the last
+// num_buckets, and the ranking is a sorted set that's only touched for the words that changed,
+// so advancing the window costs O(changed words) and not a recount
+// with a bucket width like "60s" buckets are closed by time instead: every line starts with a unix
+// timestamp (seconds, as in most log formats' epoch mode) that picks its bucket and isn't counted
+// as a word. lines without one, or with one older than the current bucket, go in the current bucket,
+// and buckets nothing arrived in still take up their place in the window
+// with decay < 1 the bucket of age a is weighted decay^a instead of 1, and buckets that weigh
+// less than weight_epsilon are dropped early
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cfloat>
+#include <deque>
+#include <set>
+#include <vector>
+
+#include <chrono> // for the timer
+
+#define rescale_bound 1e150  // the lazy scale factor is folded into the scores once it passes this
+#define weight_epsilon 1e-12  // buckets weighted less than this (relative to the newest) are dropped
+
+struct window_entry
+{
+    long count = 0;     // occurrences in the window, the word leaves the window when this hits 0
+    double score = 0.0; // decay weighted count, times the scale factor at the time it was added
+};
+
+struct bucket
+{
+    long id;
+    std::unordered_map<std::string, long> tally;
+};
+
+struct window_tally
+{
+    int num_buckets; // buckets actually kept: the window, or fewer if older ones weigh under weight_epsilon
+    double growth;   // 1 / decay: newer buckets get bigger weights instead of decaying the old ones
+    long epoch = 0;  // id of the bucket whose weight is 1, the scale factor is growth^(newest - epoch)
+
+    std::unordered_map<std::string, window_entry> words;
+    std::set<std::pair<double, const std::string *>, std::greater<std::pair<double, const std::string *>>> ranking;
+    std::deque<bucket> buckets;
+
+    window_tally(int window_buckets, double decay) : num_buckets(window_buckets), growth(1.0 / decay)
+    {
+        if (decay < 1.0){
+            // in double first, for a decay close to 1 this is way past INT_MAX
+            num_buckets = (int)std::min((double)num_buckets, std::floor(std::log(weight_epsilon) / std::log(decay)) + 1.0);
+        }
+    }
+
+    double weight(long id) const
+    {
+        return std::pow(growth, (double)(id - epoch));
+    }
+
+    void update(const std::string &word, long count, double score)
+    {
+        auto it = words.emplace(word, window_entry()).first;
+        window_entry &entry = it->second;
+        if (entry.count > 0){
+            ranking.erase(std::make_pair(entry.score, &it->first));
+        }
+        entry.count += count;
+        entry.score += score;
+        if (entry.count == 0){
+            words.erase(it);
+            return;
+        }
+        ranking.insert(std::make_pair(entry.score, &it->first));
+    }
+
+    // the closed bucket enters the window, and the buckets that are num_buckets or more older leave
+    // (ids can skip when buckets are closed by time, the skipped ones were empty)
+    void advance(bucket &entering)
+    {
+        while (!buckets.empty() && buckets.front().id <= entering.id - num_buckets){
+            bucket &leaving = buckets.front();
+            double w = weight(leaving.id);
+            for (const auto &pair : leaving.tally){
+                update(pair.first, -pair.second, -pair.second * w);
+            }
+            buckets.pop_front();
+        }
+        if (buckets.empty()){
+            epoch = entering.id; // nothing left to rescale
+        }
+
+        // scores stay relative to the epoch, the newest bucket's weight is the lazy scale factor; once
+        // it passes rescale_bound every score is divided by it and the newest bucket becomes the epoch.
+        // that's every log(rescale_bound) / log(growth) buckets whatever the window size, and the
+        // order doesn't change, so the ranking is rebuilt in place order in O(words)
+        double scale = weight(entering.id);
+        if (scale > rescale_bound){
+            epoch = entering.id;
+            std::set<std::pair<double, const std::string *>, std::greater<std::pair<double, const std::string *>>> rescaled;
+            for (const auto &pair : ranking){
+                rescaled.emplace_hint(rescaled.end(), pair.first / scale, pair.second);
+            }
+            for (auto &pair : words){
+                pair.second.score /= scale;
+            }
+            ranking.swap(rescaled);
+        }
+
+        double w = weight(entering.id);
+        for (const auto &pair : entering.tally){
+            update(pair.first, pair.second, pair.second * w);
+        }
+        buckets.push_back(std::move(entering));
+    }
+
+    // actual decayed score as of the newest bucket
+    double current_score(double score) const
+    {
+        return buckets.empty() ? score : score / weight(buckets.back().id);
+    }
+};
+
+void print_top(const window_tally &window, const char *unit, long first, long last, bool decayed)
+{
+    printf("%s %ld-%ld (%zu distinct words):\n", unit, first, last, window.words.size());
+    int i = 0;
+    for (const auto &pair : window.ranking){
+        if (decayed){
+            printf("%2d. %s: %.2f\n", i, pair.second->c_str(), window.current_score(pair.first));
+        }
+        else{
+            printf("%2d. %s: %ld\n", i, pair.second->c_str(), (long)pair.first);
+        }
+
+        if (++i == 10){
+            break;
+        }
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 5 || argc > 7)
+    {
+        std::cout << "Usage: " << argv[0] << " <filename|->" << " <cache_size>" << " <bucket_lines|bucket_seconds's>" << " <num_buckets>"
+                  << " [decay]" << " [report_every]" << std::endl;
+        std::cout << "  e.g. 1000 closes a bucket every 1000 lines, 60s every minute of the lines' leading unix timestamps" << std::endl;
+        return 1;
+    }
+
+    int cache_size = atoi(argv[2]) * 1024;
+    // bucket width in lines, or in seconds with an s suffix
+    char *unit_end;
+    long bucket_width = strtol(argv[3], &unit_end, 10);
+    const bool by_time = unit_end[0] == 's' && unit_end[1] == '\0';
+    const char *unit = by_time ? "Seconds" : "Lines";
+    int num_buckets = atoi(argv[4]);
+    double decay = argc > 5 ? atof(argv[5]) : 1.0;
+    long report_every = argc > 6 ? atol(argv[6]) : num_buckets; // in buckets
+    if (cache_size <= 0 || bucket_width <= 0 || (*unit_end != '\0' && !by_time) || num_buckets <= 0 || report_every <= 0 || decay <= 0.0 || decay > 1.0)
+    {
+        std::cout << "Need cache_size, bucket width, num_buckets, report_every > 0 and 0 < decay <= 1" << std::endl;
+        return 1;
+    }
+    const bool decayed = decay < 1.0;
+    // the weight ratio between the newest and the oldest bucket kept has to fit in a double,
+    // which it does as long as there's room for weight_epsilon below the newest weight
+    window_tally window(num_buckets, decay);
+    if (decayed && (window.num_buckets - 1) * std::log(1.0 / decay) >= std::log(DBL_MAX))
+    {
+        std::cout << "decay^" << window.num_buckets - 1 << " is too small for a double, use a decay closer to 1" << std::endl;
+        return 1;
+    }
+    printf("Cache size: %d KB\n", cache_size / 1024);
+    printf("Window: %d buckets of %ld %s, decay %.3f", num_buckets, bucket_width, by_time ? "seconds" : "lines", decay);
+    if (window.num_buckets < num_buckets){
+        printf(" (only the last %d weigh more than %g)", window.num_buckets, weight_epsilon);
+    }
+    printf("\n");
+
+    // read the input a chunk at a time, "-" is stdin
+    std::ifstream file;
+    std::istream *input = &std::cin;
+    if (strcmp(argv[1], "-") != 0)
+    {
+        file.open(argv[1]);
+        if (!file.is_open())
+        {
+            std::cout << "Could not open file " << argv[1] << std::endl;
+            return 1;
+        }
+        std::cout << "Opened file " << argv[1] << std::endl;
+        input = &file;
+    }
+
+    // Delimeters for tokenizing, as a lookup table since words can run across chunks
+    const char *delim = "\"\'.“”‘’?:;-,—*($%)! \t\n\x0A\r";
+    bool is_delim[256] = {false};
+    for (const char *d = delim; *d != '\0'; d++){
+        is_delim[(unsigned char)*d] = true;
+    }
+
+    bucket current;
+    current.id = 0;
+    long line = 0;
+    bool line_start = true; // in time mode a line's timestamp is read before its words
+    long stamp = -1;        // -1 until the line has one
+    bool stamped = false;   // the first timestamp sets the first bucket's id
+
+    // the range of lines / seconds the window covers
+    auto report = [&](){
+        if (by_time){
+            print_top(window, unit, window.buckets.front().id * bucket_width,
+                      (window.buckets.back().id + 1) * bucket_width - 1, decayed);
+        }
+        else{
+            print_top(window, unit, std::max(1L, window.buckets.front().id * bucket_width + 1), line, decayed);
+        }
+    };
+
+    // close the current bucket and start bucket next_id
+    auto close_bucket = [&](long next_id){
+        long closed_id = current.id;
+        window.advance(current);
+        if (next_id / report_every != closed_id / report_every){
+            report();
+        }
+        current = bucket();
+        current.id = next_id;
+    };
+
+    // start the timer
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+
+    std::vector<char> cache(cache_size); // local cache
+    std::string word; // carries a word that runs past the end of a chunk
+    long total_size = 0;
+    while (true){
+        // copy from the stream to cache
+        input->read(&cache[0], cache_size);
+        long copy_size = input->gcount();
+        if (copy_size <= 0){
+            break;
+        }
+
+        for (long i = 0; i < copy_size; i++){
+            unsigned char c = cache[i];
+            if (by_time && line_start){
+                // leading digits are the timestamp, anything past 18 of them is dropped
+                if (c >= '0' && c <= '9'){
+                    if (stamp < 100000000000000000L){
+                        stamp = std::max(stamp, 0L) * 10 + (c - '0');
+                    }
+                    continue;
+                }
+                line_start = false;
+                if (stamp >= 0){
+                    long id = stamp / bucket_width;
+                    if (!stamped){
+                        current.id = id;
+                        stamped = true;
+                    }
+                    else if (id > current.id){
+                        close_bucket(id);
+                    }
+                }
+            }
+
+            if (!is_delim[c]){
+                // turn it to lowercase
+                word += ::tolower(c);
+                continue;
+            }
+
+            // skip if char count is less than 6
+            if (word.length() >= 6){
+                current.tally[word] += 1;
+            }
+            word.clear();
+
+            if (c == '\n'){
+                line++;
+                line_start = true;
+                stamp = -1;
+                // close the bucket every bucket_width lines
+                if (!by_time && line % bucket_width == 0){
+                    close_bucket(line / bucket_width);
+                }
+            }
+        }
+        total_size += copy_size;
+    }
+
+    // whatever is left is the last, partial bucket
+    if (word.length() >= 6){
+        current.tally[word] += 1;
+    }
+    if (!current.tally.empty() || window.buckets.empty()){
+        window.advance(current);
+    }
+
+    // stop the timer
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+
+    printf("Chunk size: %ld\n", total_size);
+    report();
+
+    // the time taken
+    auto duration = end_time - start_time;
+    auto duration_ms = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+    printf("Time taken to count words: %ld microsecs\n", duration_ms.count());
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+# batched + prefetched counting vs one tally[word] += 1 at a time
+# run from the build directory after build.sh, which builds base_batch with -O2 -march=native
+# for reference, one run of this script (g++ 12, -O2 -march=native), synthetic corpus:
+#   one at a time 19.0-19.9 s, batched: 11.7 s (batch 1), 4.6 s (8), 4.0 s (16), 3.9 s (32), 4.1 s (64)
+echo "WarAndPeace.txt (fits in cache)"
+./base_batch ../WarAndPeace.txt
+for batch in 1 8 16 32 64
+do
+    echo "synthetic: 20M words, 4M distinct, batch size $batch"
+    ./base_batch --synthetic 20000000 4000000 $batch | tail -4
+done
+echo "done"
@@ -12,8 +12,28 @@ echo "building base_omp_TLS.cpp"
 g++ -O0 ../base_omp_TLS.cpp -o base_omp_TLS -fopenmp -march=native
 echo "building base_omp_TLS_cache.cpp"
 g++ -O0 ../base_omp_TLS_cache.cpp -o base_omp_TLS_cache -fopenmp -march=native
+echo "building base_omp_hll.cpp"
+# -O2 so the register update / merge loops get vectorized
+g++ -O2 ../base_omp_hll.cpp -o base_omp_hll -fopenmp -march=native
+echo "building base_omp_ngram.cpp"
+g++ -O0 ../base_omp_ngram.cpp -o base_omp_ngram -fopenmp -march=native
+echo "building base_pool.cpp"
+g++ -O0 ../base_pool.cpp -o base_pool -fopenmp -pthread -march=native
 # echo "building base_omp_cache.cpp"
 # g++ -O0 ../base_omp_cache.cpp -o base_omp_cache -fopenmp
+echo "building base_window.cpp"
+g++ -O0 ../base_window.cpp -o base_window -march=native
+echo "building base_batch.cpp"
+# -O2: this one is a benchmark, at -O0 the hash + probe loops are nowhere near what ships
+g++ -O2 ../base_batch.cpp -o base_batch -march=native
+echo "building base_compact.cpp"
+g++ -O0 ../base_compact.cpp -o base_compact -march=native
+echo "building gen_corpus.cpp"
+g++ -O2 ../gen_corpus.cpp -o gen_corpus -march=native
+echo "building base_server.cpp"
+g++ -O2 ../base_server.cpp -o base_server -pthread -march=native
+echo "building server_loadgen.cpp"
+g++ -O2 ../server_loadgen.cpp -o server_loadgen -pthread -march=native
 # echo "copying testrun.sh"
 # cp ../testrun.sh ./testrun.sh
 # chmod +x ./testrun.sh
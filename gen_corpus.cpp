@@ -0,0 +1,217 @@
+// synthetic corpus generator for the scaling tests: WarAndPeace.txt is ~3MB and ~14k distinct
+// words, which fits in cache and says nothing about large inputs or high cardinality
+// words are drawn from a fixed vocabulary with a zipfian or uniform distribution and written out
+// in 1MB blocks, so the output can be far bigger than memory (up to 100GB and beyond)
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <chrono> // for the timer
+
+// 2 and 3 byte UTF-8 letters, none of their bytes are in the tokenizer's delimiter set
+const char *utf8_letters[] = {"é", "ó", "ü", "ñ", "ß", "ж", "я", "中", "語"};
+const int num_utf8_letters = sizeof(utf8_letters) / sizeof(utf8_letters[0]);
+
+// punctuation mixed in between words, all of these are delimiters for the counters
+const char *punctuation[] = {".", ",", ";", ":", "!", "?", "-", "—", "“", "”", "(", ")"};
+const int num_punctuation = sizeof(punctuation) / sizeof(punctuation[0]);
+
+// parses 100, 64K, 16M, 100G
+bool parse_size(const char *text, uint64_t &size)
+{
+    char *end;
+    double value = strtod(text, &end);
+    switch (*end){
+        case 'k': case 'K': value *= 1024.0; end++; break;
+        case 'm': case 'M': value *= 1024.0 * 1024.0; end++; break;
+        case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; end++; break;
+    }
+    size = (uint64_t)value;
+    return *end == '\0' && value > 0;
+}
+
+void usage(const char *name)
+{
+    std::cout << "Usage: " << name << " <output_filename>" << " <size>" << " [options]" << std::endl;
+    std::cout << "  size              bytes, with an optional K/M/G suffix" << std::endl;
+    std::cout << "  --dist D          zipf or uniform (default zipf)" << std::endl;
+    std::cout << "  --zipf-s S        zipf exponent (default 1.0)" << std::endl;
+    std::cout << "  --vocab N         vocabulary size (default 100000)" << std::endl;
+    std::cout << "  --min-len N       shortest word in letters (default 2)" << std::endl;
+    std::cout << "  --max-len N       longest word in letters (default 14)" << std::endl;
+    std::cout << "  --delim-density P chance of punctuation after a word (default 0.1)" << std::endl;
+    std::cout << "  --utf8 P          chance of a letter being multi-byte UTF-8 (default 0.02)" << std::endl;
+    std::cout << "  --upper P         chance of a word being capitalized (default 0.05)" << std::endl;
+    std::cout << "  --seed N          random seed (default 746)" << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 3 || (argc - 3) % 2 != 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    uint64_t size;
+    if (!parse_size(argv[2], size))
+    {
+        std::cout << "Bad size " << argv[2] << std::endl;
+        return 1;
+    }
+
+    bool zipf = true;
+    double zipf_s = 1.0;
+    long vocab_size = 100000;
+    int min_len = 2;
+    int max_len = 14;
+    double delim_density = 0.1;
+    double utf8 = 0.02;
+    double upper = 0.05;
+    uint64_t seed = 746;
+    for (int a = 3; a < argc; a += 2){
+        const char *opt = argv[a];
+        const char *value = argv[a + 1];
+        if (strcmp(opt, "--dist") == 0 && (strcmp(value, "zipf") == 0 || strcmp(value, "uniform") == 0)){
+            zipf = strcmp(value, "zipf") == 0;
+        }
+        else if (strcmp(opt, "--zipf-s") == 0){
+            zipf_s = atof(value);
+        }
+        else if (strcmp(opt, "--vocab") == 0){
+            vocab_size = atol(value);
+        }
+        else if (strcmp(opt, "--min-len") == 0){
+            min_len = atoi(value);
+        }
+        else if (strcmp(opt, "--max-len") == 0){
+            max_len = atoi(value);
+        }
+        else if (strcmp(opt, "--delim-density") == 0){
+            delim_density = atof(value);
+        }
+        else if (strcmp(opt, "--utf8") == 0){
+            utf8 = atof(value);
+        }
+        else if (strcmp(opt, "--upper") == 0){
+            upper = atof(value);
+        }
+        else if (strcmp(opt, "--seed") == 0){
+            seed = strtoull(value, NULL, 10);
+        }
+        else{
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (vocab_size < 1 || min_len < 1 || max_len < min_len)
+    {
+        std::cout << "Need vocab >= 1 and 1 <= min-len <= max-len" << std::endl;
+        return 1;
+    }
+
+    FILE *out = fopen(argv[1], "wb");
+    if (out == NULL)
+    {
+        std::cout << "Could not open file " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+
+    // build the vocabulary, rank 0 is the most frequent word under zipf
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::vector<std::string> vocab(vocab_size);
+    for (std::string &word : vocab){
+        int length = min_len + rng() % (max_len - min_len + 1);
+        for (int i = 0; i < length; i++){
+            if (chance(rng) < utf8){
+                word += utf8_letters[rng() % num_utf8_letters];
+            }
+            else{
+                word += (char)('a' + rng() % 26);
+            }
+        }
+    }
+
+    // zipf: cumulative weights 1 / rank^s, sampled with a binary search
+    std::vector<double> cdf;
+    if (zipf){
+        cdf.resize(vocab_size);
+        double sum = 0.0;
+        for (long r = 0; r < vocab_size; r++){
+            sum += 1.0 / std::pow((double)(r + 1), zipf_s);
+            cdf[r] = sum;
+        }
+        for (double &c : cdf){
+            c /= sum;
+        }
+    }
+
+    // write words out a block at a time
+    const size_t block_size = 1 << 20;
+    std::string block;
+    block.reserve(block_size + 256);
+    uint64_t written = 0;
+    uint64_t num_words = 0;
+    int words_on_line = 0;
+    while (written < size){
+        long rank = zipf ? std::lower_bound(cdf.begin(), cdf.end(), chance(rng)) - cdf.begin() : rng() % vocab_size;
+        rank = std::min(rank, vocab_size - 1);
+        const std::string &word = vocab[rank];
+
+        // stop before a word would run past the requested size, pad the rest with spaces
+        if (written + block.size() + word.size() + 4 > size){
+            block.append(size - written - block.size(), ' ');
+            block.back() = '\n';
+            if (fwrite(block.data(), 1, block.size(), out) != block.size()){
+                break; // reported below
+            }
+            written += block.size();
+            break;
+        }
+
+        block += word;
+        if (chance(rng) < upper && word[0] >= 'a' && word[0] <= 'z'){
+            block[block.size() - word.size()] = word[0] - 'a' + 'A';
+        }
+        if (chance(rng) < delim_density){
+            block += punctuation[rng() % num_punctuation];
+        }
+        block += ++words_on_line == 12 ? '\n' : ' ';
+        words_on_line %= 12;
+        num_words++;
+
+        if (block.size() >= block_size){
+            if (fwrite(block.data(), 1, block.size(), out) != block.size()){
+                break; // reported below
+            }
+            written += block.size();
+            block.clear();
+        }
+    }
+    // a short write (e.g. a full disk) or a failed flush means the corpus is truncated
+    bool failed = ferror(out) != 0 || written != size;
+    if (fclose(out) != 0 || failed)
+    {
+        std::cout << "Could not write " << argv[1] << ": " << strerror(errno) << " (" << written << " of " << size
+                  << " bytes written)" << std::endl;
+        return 1;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    printf("Wrote %lu bytes, %lu words (%s, vocab %ld) to %s in %ld ms\n", written, num_words,
+           zipf ? "zipf" : "uniform", vocab_size, argv[1], duration_ms.count());
+
+    return 0;
+}
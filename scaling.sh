@@ -0,0 +1,79 @@
+#!/bin/bash
+# scaling suite: runs every counting strategy over corpus size x vocabulary x thread count on
+# corpora from gen_corpus and checks each one's top 10 against the serial base
+# run from the build directory after build.sh, override the sweep with e.g.
+#   SIZES="1M 64M 1G" VOCABS="1000 1000000" THREADS="1 2 4 8" DIST=uniform ../scaling.sh
+# note: the original variants keep the file size in an int, so keep SIZES under 2G for them
+SIZES=${SIZES:-"1M 16M 64M"}
+VOCABS=${VOCABS:-"1000 100000 1000000"}
+THREADS=${THREADS:-"1 2 4"}
+DIST=${DIST:-zipf}
+CACHE_KB=${CACHE_KB:-64}
+CORPUS=${CORPUS:-/tmp/scaling_corpus.txt}
+
+# the top 10 a run printed, in a form that doesn't depend on how ties were ordered:
+# the 10 counts in order, then the words whose count is above the 10th (those can't tie out of the list)
+top10()
+{
+    grep -E '^ ?[0-9]\. ' | awk '{ count[NR] = $NF; line[NR] = $0 }
+        END { for (i = 1; i <= NR; i++) print count[i];
+              for (i = 1; i <= NR; i++) if (count[i] > count[NR]) { sub(/^ ?[0-9]+\. /, "", line[i]); print line[i] } }' | sort
+}
+
+# microseconds of the (last) timed counting pass
+micros()
+{
+    grep 'Time taken to count words' | tail -1 | awk '{ print $(NF - 1) }'
+}
+
+failed=0
+runs=0
+check()
+{
+    name=$1
+    threads=$2
+    output=$3
+    runs=$((runs + 1))
+    if [ "$(echo "$output" | top10)" = "$expected" ]
+    then
+        result="ok"
+    else
+        result="MISMATCH"
+        failed=$((failed + 1))
+    fi
+    printf "%-20s %6s %9s %8s %12s  %s\n" "$name" "$size" "$vocab" "$threads" "$(echo "$output" | micros)" "$result"
+}
+
+printf "%-20s %6s %9s %8s %12s  %s\n" "strategy" "size" "vocab" "threads" "microsecs" "vs base"
+for size in $SIZES
+do
+    for vocab in $VOCABS
+    do
+        ./gen_corpus $CORPUS $size --dist $DIST --vocab $vocab > /dev/null || exit 1
+
+        reference=$(./base $CORPUS)
+        expected=$(echo "$reference" | top10)
+        check base 1 "$reference"
+
+        # serial strategies
+        check base_cache 1 "$(./base_cache $CORPUS $CACHE_KB)"
+        check base_batch 1 "$(./base_batch $CORPUS)"
+        check base_compact 1 "$(./base_compact $CORPUS)"
+
+        # parallel strategies
+        for threads in $THREADS
+        do
+            export OMP_NUM_THREADS=$threads
+            check base_omp_TLS $threads "$(./base_omp_TLS $CORPUS)"
+            check base_omp_TLS_cache $threads "$(./base_omp_TLS_cache $CORPUS $CACHE_KB)"
+            check base_omp_hll $threads "$(./base_omp_hll $CORPUS)"
+            check base_omp_ngram $threads "$(./base_omp_ngram $CORPUS 1 6)"
+            check base_pool_omp $threads "$(./base_pool $CORPUS $CACHE_KB omp $threads 3)"
+            check base_pool_pool $threads "$(./base_pool $CORPUS $CACHE_KB pool $threads 3)"
+        done
+    done
+done
+rm -f $CORPUS
+
+echo "$runs runs, $failed mismatches"
+[ $failed -eq 0 ]
@@ -0,0 +1,230 @@
+// load generator for base_server: hammers it with a mix of TOP / COUNT / PREFIX queries from
+// several clients at once (optionally while another client keeps adding documents) and reports
+// the query latency percentiles
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <random>
+#include <atomic>
+
+#include <chrono> // for the timer
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+struct client
+{
+    int fd = -1;
+    char buffer[64 * 1024];
+    size_t start = 0, end = 0;
+
+    bool connect_to(const char *path)
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+        return fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    }
+
+    bool send_all(const char *data, size_t size)
+    {
+        size_t sent = 0;
+        while (sent < size){
+            ssize_t n = write(fd, data + sent, size - sent);
+            if (n <= 0){
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+    bool read_line(std::string &line)
+    {
+        line.clear();
+        while (true){
+            char *newline = (char *)memchr(&buffer[start], '\n', end - start);
+            if (newline != NULL){
+                line.append(&buffer[start], newline - &buffer[start]);
+                start = newline - buffer + 1;
+                return true;
+            }
+            line.append(&buffer[start], end - start);
+            start = end = 0;
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n <= 0){
+                return false;
+            }
+            end = n;
+        }
+    }
+
+    // send one request and collect the reply lines (lists end with "END")
+    bool request(const std::string &req, bool list, std::vector<std::string> &reply)
+    {
+        reply.clear();
+        if (!send_all(req.data(), req.size())){
+            return false;
+        }
+        std::string line;
+        while (read_line(line)){
+            if (!list){
+                reply.push_back(line);
+                return true;
+            }
+            if (line == "END"){
+                return true;
+            }
+            reply.push_back(line);
+        }
+        return false;
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 4)
+    {
+        std::cout << "Usage: " << argv[0] << " <socket_path>" << " <num_clients>" << " <queries_per_client>"
+                  << " [ingest_filename]" << std::endl;
+        return 1;
+    }
+
+    const char *path = argv[1];
+    int num_clients = atoi(argv[2]);
+    int num_queries = atoi(argv[3]);
+
+    // grab a vocabulary to query from the server itself
+    client setup;
+    if (!setup.connect_to(path))
+    {
+        std::cout << "Could not connect to " << path << std::endl;
+        return 1;
+    }
+    std::vector<std::string> vocab, reply;
+    setup.request("TOP 1000\n", true, reply); // the server keeps at most 1000 (max_top) ready
+    for (const std::string &line : reply){
+        vocab.push_back(line.substr(0, line.find(' ')));
+    }
+    if (vocab.empty()){
+        vocab.push_back("nothing");
+    }
+    close(setup.fd);
+
+    // optional writer: keeps adding the ingest file in 64KB documents until the readers are done
+    std::atomic<bool> stop(false);
+    std::atomic<long> documents_added(0);
+    std::thread writer;
+    std::string ingest_text;
+    if (argc > 4)
+    {
+        std::ifstream file(argv[4]);
+        if (!file.is_open())
+        {
+            std::cout << "Could not open file " << argv[4] << std::endl;
+            return 1;
+        }
+        ingest_text.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        writer = std::thread([&](){
+            client conn;
+            if (!conn.connect_to(path) || ingest_text.empty()){
+                return;
+            }
+            const size_t doc_size = 64 * 1024;
+            size_t offset = 0;
+            std::vector<std::string> ok;
+            while (!stop.load()){
+                size_t size = std::min(doc_size, ingest_text.size() - offset);
+                std::string header = "ADD " + std::to_string(size) + "\n";
+                if (!conn.send_all(header.data(), header.size()) || !conn.send_all(&ingest_text[offset], size)){
+                    break;
+                }
+                std::string line;
+                if (!conn.read_line(line)){
+                    break;
+                }
+                documents_added++;
+                offset = (offset + size) % ingest_text.size();
+            }
+            close(conn.fd);
+        });
+    }
+
+    // readers: each one records the latency of every query it makes
+    std::vector<std::vector<long>> latencies(num_clients);
+    std::vector<std::thread> readers;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
+    for (int c = 0; c < num_clients; c++){
+        readers.emplace_back([&, c](){
+            client conn;
+            if (!conn.connect_to(path)){
+                return;
+            }
+            std::mt19937 rng(c);
+            std::vector<std::string> reply;
+            latencies[c].reserve(num_queries);
+            for (int q = 0; q < num_queries; q++){
+                // 20% TOP, 60% COUNT, 20% PREFIX
+                int kind = rng() % 10;
+                const std::string &word = vocab[rng() % vocab.size()];
+                std::string req;
+                bool list = true;
+                if (kind < 2){
+                    req = "TOP 10\n";
+                }
+                else if (kind < 8){
+                    req = "COUNT " + word + "\n";
+                    list = false;
+                }
+                else{
+                    req = "PREFIX " + word.substr(0, 3) + " 10\n";
+                }
+
+                std::chrono::time_point<std::chrono::high_resolution_clock> t0 = std::chrono::high_resolution_clock::now();
+                if (!conn.request(req, list, reply)){
+                    break;
+                }
+                std::chrono::time_point<std::chrono::high_resolution_clock> t1 = std::chrono::high_resolution_clock::now();
+                latencies[c].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            }
+            close(conn.fd);
+        });
+    }
+    for (std::thread &t : readers){
+        t.join();
+    }
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
+
+    stop = true;
+    if (writer.joinable()){
+        writer.join();
+    }
+
+    std::vector<long> all;
+    for (const std::vector<long> &l : latencies){
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    if (all.empty())
+    {
+        std::cout << "No queries completed" << std::endl;
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+
+    auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+    printf("Clients: %d, queries: %zu, documents added: %ld\n", num_clients, all.size(), documents_added.load());
+    printf("Throughput: %.0f queries/sec\n", all.size() * 1e6 / std::max(duration_us, 1L));
+    printf("Latency p50: %.1f microsecs\n", all[all.size() * 50 / 100] / 1000.0);
+    printf("Latency p99: %.1f microsecs\n", all[all.size() * 99 / 100] / 1000.0);
+    printf("Latency max: %.1f microsecs\n", all.back() / 1000.0);
+
+    return 0;
+}